@@ -0,0 +1,312 @@
+#!/usr/bin/python
+"""
+olaFoam Project - binary paddle time series converter
+
+Converts the inline time series of a wavemakerMovementDict (paddlePosition,
+paddleTilt, paddleEta) or of a wavemaker waveDict (tx, tv, txeta, tveta) to
+the binary format memory-mapped by the boundary conditions (waveTimeSeries).
+
+Usage:
+    waveTimeSeriesConvert.py DICT BINFILE [-d NEWDICT]
+    waveTimeSeriesConvert.py --info BINFILE
+
+    DICT     Dictionary with the inline series (#include is followed)
+    BINFILE  Binary file to write, usually in constant
+    NEWDICT  Dictionary to write without the series and with the
+             timeSeriesFile entry (if NEWDICT is DICT, DICT.orig is kept)
+
+waveDict series are derived as the boundary conditions do (waveTheory tveta),
+so the binary file always holds paddleVelocity and paddleEta.
+
+Binary layout (native byte order, 8-byte words):
+    char[8]   "OLATSER1"
+    int64     1 (byte order check)
+    int64     nRows
+    int64     nSeries
+    nSeries x { char[32] name; int64 nColumns; }
+    double    data[nRows][1 + sum(nColumns)]   (time first)
+"""
+
+import os
+import re
+import sys
+import shutil
+import struct
+from array import array
+
+MAGIC = b'OLATSER1'
+
+SERIES_KEYS = ['timeSeries', 'paddlePosition', 'paddleVelocity', 'paddleEta',
+               'paddleTilt']
+
+TOKEN = re.compile(r'''
+    (?P<comment>//[^\n]*|/\*.*?\*/)
+  | (?P<string>"[^"]*")
+  | (?P<punct>[(){};])
+  | (?P<word>[^\s(){};"]+)
+  | (?P<space>\s+)
+''', re.S | re.X)
+
+
+## Dictionary parsing ##
+
+def tokenize(text):
+    for m in TOKEN.finditer(text):
+        kind = m.lastgroup
+        if kind in ('comment', 'space'):
+            continue
+        yield kind, m.group(kind), m.start(), m.end()
+
+
+def parseValue(tokens, i):
+    """Parse a value starting at tokens[i], return (value, next index)"""
+    kind, tok = tokens[i][0], tokens[i][1]
+
+    # Sized list N( ... ) or uniform list N{ value }
+    if (kind == 'word' and i+1 < len(tokens) and tokens[i+1][1] in '({'
+            and tok.isdigit()):
+        if tokens[i+1][1] == '{':
+            value, j = parseValue(tokens, i+2)
+            return [value]*int(tok), j+1
+        i += 1
+        tok = '('
+
+    if tok == '(':
+        values = []
+        i += 1
+        while tokens[i][1] != ')':
+            value, i = parseValue(tokens, i)
+            values.append(value)
+        return values, i+1
+
+    if tok == '{':
+        depth = 1
+        i += 1
+        while depth:
+            depth += {'{': 1, '}': -1}.get(tokens[i][1], 0)
+            i += 1
+        return None, i
+
+    try:
+        return float(tok), i+1
+    except ValueError:
+        return tok.strip('"'), i+1
+
+
+def readDict(path, entries=None):
+    """Top level entries of an OpenFOAM dictionary:
+    list of (keyword, value, raw text)"""
+    if entries is None:
+        entries = []
+
+    text = open(path).read()
+    tokens = list(tokenize(text))
+    i = 0
+
+    while i < len(tokens):
+        kind, tok, start, end = tokens[i]
+
+        if tok == '#include' or tok == '#includeIfPresent':
+            incl = tokens[i+1][1].strip('"')
+            incl = os.path.join(os.path.dirname(path), incl)
+            if tok == '#include' or os.path.isfile(incl):
+                readDict(incl, entries)
+            i += 2
+            continue
+
+        if tok.startswith('#'):
+            i += 2
+            continue
+
+        keyword = tok
+        i += 1
+
+        if tokens[i][1] == '{':
+            value, i = parseValue(tokens, i)
+        else:
+            values = []
+            while tokens[i][1] != ';':
+                value, i = parseValue(tokens, i)
+                values.append(value)
+            value = values[0] if len(values) == 1 else values
+            i += 1
+
+        entries.append((keyword, value, text[start:tokens[i-1][3]]))
+
+    return entries
+
+
+## Series ##
+
+def fail(msg):
+    sys.stderr.write('Error: ' + msg + '\n')
+    sys.exit(1)
+
+
+def checkColumns(name, columns, nRows):
+    for j, col in enumerate(columns):
+        if len(col) != nRows:
+            fail('Check number of components of each of the series in '
+                 '{0}:\nExpected: {1}; Found: {2} (column {3})'.format(
+                     name, nRows, len(col), j))
+
+
+def wavemakerSeries(d):
+    """Series of a wavemakerMovementDict"""
+    wmType = d.get('wavemakerType', 'Piston')
+    genAbs = str(d.get('genAbs', 0)) in ('1', '1.0', 'true', 'on', 'yes')
+
+    series = []
+
+    if wmType in ('Piston', 'Mixed'):
+        series.append(('paddlePosition', d['paddlePosition']))
+    if wmType in ('Flap', 'Mixed'):
+        series.append(('paddleTilt', d['paddleTilt']))
+    if wmType == 'Piston' and genAbs:
+        if 'paddleEta' not in d:
+            print('No paddleEta provided. Assuming: paddleEta = paddlePosition')
+        series.append(('paddleEta', d.get('paddleEta', d['paddlePosition'])))
+
+    return series
+
+
+def waveDictSeries(d, times):
+    """Series of a wavemaker waveDict, derived as checkInputErrorsWavemaker.H"""
+    theory = d.get('waveTheory')
+    n = len(times)
+
+    if theory in ('tx', 'txeta'):
+        x = d['paddlePosition']
+        vel = [0.0]*n
+        for i in range(n-1):
+            vel[i] = (x[i+1] - x[i])/(times[i+1] - times[i])
+    else:
+        vel = d['paddleVelocity']
+
+    if theory == 'tx':
+        eta = [xi - x[0] for xi in x]
+    elif theory == 'tv':
+        eta = [0.0]*n
+        for i in range(1, n):
+            eta[i] = eta[i-1] + vel[i-1]*(times[i] - times[i-1])
+    elif theory in ('txeta', 'tveta'):
+        eta = d['paddleEta']
+    else:
+        fail('Wave theory not specified for wavemaker, use:\n'
+             'tx, tv, txeta, tveta.')
+
+    return [('paddleVelocity', [vel]), ('paddleEta', [eta])]
+
+
+def writeBinary(path, times, series):
+    nRows = len(times)
+    columns = [col for name, cols in series for col in cols]
+
+    with open(path, 'wb') as f:
+        f.write(MAGIC)
+        f.write(struct.pack('=qqq', 1, nRows, len(series)))
+        for name, cols in series:
+            f.write(struct.pack('=32sq', name.encode(), len(cols)))
+
+        row = array('d', [0.0]*(1 + len(columns)))
+        for r in range(nRows):
+            row[0] = times[r]
+            for j, col in enumerate(columns):
+                row[j+1] = col[r]
+            row.tofile(f)
+
+
+def info(path):
+    with open(path, 'rb') as f:
+        if f.read(8) != MAGIC:
+            fail(path + ' is not an olaFoam binary time series file.')
+        order, nRows, nSeries = struct.unpack('=qqq', f.read(24))
+        if order != 1:
+            fail(path + ' was written with a different byte order.')
+        print('{0}: {1} samples'.format(path, nRows))
+        for s in range(nSeries):
+            name, nCols = struct.unpack('=32sq', f.read(40))
+            print('    {0} {1}'.format(
+                name.rstrip(b'\0').decode(), nCols))
+
+
+def writeDict(path, entries, binFile, dictName):
+    header = (
+        'FoamFile\n{\n'
+        '    version     2.0;\n'
+        '    format      ascii;\n'
+        '    class       dictionary;\n'
+        '    location    "constant";\n'
+        '    object      ' + dictName + ';\n'
+        '}\n'
+        '// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * '
+        '* * * * //\n\n')
+
+    with open(path, 'w') as f:
+        f.write(header)
+        for keyword, value, raw in entries:
+            if keyword in SERIES_KEYS + ['FoamFile', 'timeSeriesFile']:
+                continue
+            f.write(raw + '\n')
+        f.write('\ntimeSeriesFile  "{0}";\n'.format(binFile))
+
+
+## Main ##
+
+if __name__ == '__main__':
+    args = sys.argv[1:]
+
+    if len(args) == 2 and args[0] == '--info':
+        info(args[1])
+        sys.exit(0)
+
+    newDict = None
+    if '-d' in args:
+        k = args.index('-d')
+        newDict = args[k+1]
+        del args[k:k+2]
+
+    if len(args) != 2:
+        print(__doc__)
+        sys.exit(1)
+
+    dictPath, binPath = args
+
+    entries = readDict(dictPath)
+    d = dict((keyword, value) for keyword, value, raw in entries)
+
+    if 'timeSeries' not in d:
+        fail('No timeSeries in ' + dictPath)
+
+    times = d['timeSeries']
+    nRows = len(times)
+
+    if nRows < 2:
+        fail('Check number of components of timeSeries (>1)')
+
+    for i in range(nRows-1):
+        if times[i+1] <= times[i]:
+            fail('timeSeries must be strictly increasing '
+                 '(sample {0}: {1} -> {2})'.format(i, times[i], times[i+1]))
+
+    if 'wavemakerType' in d or 'paddleTilt' in d:
+        series = wavemakerSeries(d)
+    else:
+        series = waveDictSeries(d, times)
+
+    for name, cols in series:
+        checkColumns(name, cols, nRows)
+
+    writeBinary(binPath, times, series)
+    info(binPath)
+
+    if newDict:
+        # Relative to the dictionary directory (constant)
+        binRef = os.path.relpath(binPath, os.path.dirname(newDict) or '.')
+        dictName = os.path.basename(dictPath)
+
+        if os.path.abspath(newDict) == os.path.abspath(dictPath):
+            shutil.copy(dictPath, dictPath + '.orig')
+
+        writeDict(newDict, entries, binRef, dictName)
+        print('Written ' + newDict)